@@ -0,0 +1,138 @@
+#fit-only entry point for short batch jobs: fits delta of Raa = (1 - delta/pt)^(n-2) to the binary cache
+#(TABLE.csv.npy) that the notebook writes for a HEPData table, with the python standard library only, so that
+#numpy, scipy and matplotlib are never imported; run it as
+#    python -S raa_fit.py TABLE.csv.npy [pt_min] [n]
+#and it prints delta, its error, the chi2 and the number of iterations.
+#This file is also the reference of the one-parameter solver: the bracket update (bracketed_step), the stopping
+#rule (step_converged, at_bound), the default tolerance and iterations and the solver version are defined only here and
+#imported by solve_delta in the notebook, which does the same iterations on numpy arrays (with whitening by a
+#full covariance and preallocated buffers); initial_delta only sets the start of the bracketed iterations
+import mmap
+import os
+import sys
+
+#version of the solver, part of the key of the fits cached by the notebook: increase it with every change of
+#the solver that can change its results, so that the fits cached by the previous versions are not used
+solver_version = 4
+
+#default tolerance on the step (relative to 1 + |delta|) and maximum number of iterations
+solver_tol, solver_max_iter = 1e-10, 50
+
+#columns of the HEPData table
+pt_column, Raa_column, stat_column = 0, 3, 4
+
+#columns of a .npy file of little-endian doubles with shape (columns, points), mapped without copies; a file
+#that is not such a table, or whose data are not exactly columns x points doubles (e.g. truncated), is a ValueError
+def load_columns(path):
+    with open(path, 'rb') as cache:
+        data = mmap.mmap(cache.fileno(), 0, access=mmap.ACCESS_READ)
+    if data[:6] != b'\x93NUMPY' or len(data) < 12:
+        raise ValueError(path + ' is not a .npy file')
+    header_length = int.from_bytes(data[8:10], 'little') if data[6] == 1 else int.from_bytes(data[8:12], 'little')
+    header_start = 10 if data[6] == 1 else 12
+    if len(data) < header_start + header_length:
+        raise ValueError(path + ': the header is truncated')
+    header = data[header_start:header_start + header_length].decode('latin1')
+    if "'<f8'" not in header or "'fortran_order': False" not in header or "'shape':" not in header:
+        raise ValueError(path + ': only C-ordered little-endian float64 tables are supported')
+    shape = header.split("'shape':", 1)[1].split('(', 1)[1].split(')', 1)[0].split(',')
+    if len(shape) < 2 or not shape[1].strip():
+        raise ValueError(path + ': only tables of shape (columns, points) are supported')
+    columns, points = (int(size) for size in shape[:2])
+    if len(data) - header_start - header_length != 8*columns*points:
+        raise ValueError('%s: %d bytes of data instead of %d for %d x %d doubles, the file is truncated or corrupted'
+                         % (path, len(data) - header_start - header_length, 8*columns*points, columns, points))
+    values = memoryview(data)[header_start + header_length:].cast('d')
+    return [values[i*points:(i + 1)*points] for i in range(columns)]
+
+#initial guess of delta, the same estimate as initial_delta in the notebook (see there)
+def initial_delta(x, y, sigma, n, fallback=1):
+    high = 0.999 * min(x)
+    num = den = 0.0
+    for x_i, y_i, s_i in zip(x, y, sigma):
+        if y_i > 0:
+            root = y_i**(1/(n-2))
+            weight = ((n-2) * y_i / (x_i * root * s_i))**2
+            num += weight * x_i*(1 - root)
+            den += weight
+    return min(num/den if den else fallback, high)
+
+#one gauss-newton step inside the bracket [low, high] of the minimum: g and h are the derivative of chi2/2 and
+#its gauss-newton second derivative at delta; the sign of g tells on which side of delta the minimum is, and a
+#step leaving the bracket is replaced by a bisection (a step below the rounding of delta may land on an end of
+#the bracket, that is still inside it). Returns the step and the new bracket
+def bracketed_step(delta, g, h, low, high):
+    if g > 0:
+        high = delta
+    elif g < 0:
+        low = delta
+    step = -g/h
+    if not low <= delta + step <= high:
+        step = (low + high)/2 - delta
+    return step, low, high
+
+#true when the step that gave delta is below the tolerance
+def step_converged(step, delta, tol):
+    return abs(step) < tol * (1 + abs(delta))
+
+#true when delta converged onto the upper bound of the bracket (just below the smallest pt): the chi2 minimum
+#is at or beyond the bound, where the model is not defined, so this is not a fit (the bisection crawls into
+#the bound with shrinking steps that pass step_converged)
+def at_bound(delta, bound, tol):
+    return delta >= bound - tol * (1 + abs(bound))
+
+#gauss-newton fit of delta starting from initial_delta, with high starting just below the smallest pt;
+#returns delta, its error, the chi2 and the number of iterations (nan if it did not converge or ended on the bound)
+def solve_delta(x, y, sigma, n, tol=solver_tol, max_iter=solver_max_iter):
+    low, high = float('-inf'), 0.999 * min(x)
+    bound = high
+    delta = initial_delta(x, y, sigma, n)
+    for iteration in range(1, max_iter + 1):
+        g = h = chi2 = 0.0
+        for x_i, y_i, s_i in zip(x, y, sigma):
+            b = 1 - delta/x_i
+            p = b**(n-3)
+            r = (y_i - b*p)/s_i
+            j = -(n-2)/x_i * p/s_i
+            g -= j*r
+            h += j*j
+            chi2 += r*r
+        step, low, high = bracketed_step(delta, g, h, low, high)
+        delta += step
+        if step_converged(step, delta, tol):
+            if at_bound(delta, bound, tol):
+                break
+            return delta, h**-0.5, chi2, iteration
+    return float('nan'), float('nan'), float('nan'), iteration
+
+def main(argv):
+    if not 2 <= len(argv) <= 4:
+        sys.exit('usage: python -S raa_fit.py TABLE.csv.npy [pt_min] [n]')
+    try:
+        pt_min = float(argv[2]) if len(argv) > 2 else 25
+        n = int(argv[3]) if len(argv) > 3 else 8
+    except ValueError as error:
+        sys.exit('usage: python -S raa_fit.py TABLE.csv.npy [pt_min] [n]: %s' % error)
+    if n <= 2:
+        sys.exit('n must be larger than 2, not %d' % n)
+    #as load_hepdata in the notebook, a cache older than its csv (TABLE.csv next to TABLE.csv.npy) is stale; it is
+    #not rebuilt here (that needs numpy), so the fit is refused until the notebook has loaded the table again
+    table = argv[1][:-len('.npy')] if argv[1].endswith('.npy') else None
+    try:
+        if table and os.path.isfile(table) and os.path.getmtime(table) > os.path.getmtime(argv[1]):
+            sys.exit('%s is older than %s: load the table in the notebook to rebuild it' % (argv[1], table))
+        columns = load_columns(argv[1])
+    except (OSError, ValueError) as error:
+        sys.exit(str(error))
+    if len(columns) <= stat_column:
+        sys.exit('%s has %d columns, not a HEPData R_AA table' % (argv[1], len(columns)))
+    pt, Raa, stat = columns[pt_column], columns[Raa_column], columns[stat_column]
+    cut = [i for i in range(len(pt)) if pt[i] >= pt_min]
+    #as fit_delta in the notebook, a fit needs at least 2 points
+    if len(cut) < 2:
+        sys.exit('%d points with pt >= %g, at least 2 are needed' % (len(cut), pt_min))
+    delta, delta_err, chi2, iterations = solve_delta([pt[i] for i in cut], [Raa[i] for i in cut], [stat[i] for i in cut], n)
+    print('delta = %.10g +- %.3g GeV/c, chi2 = %.6g (%d points), %d iterations' % (delta, delta_err, chi2, len(cut), iterations))
+
+if __name__ == '__main__':
+    main(sys.argv)